@@ -1,2 +1,2 @@
 make: graph.h tests.h graph.cpp tests.cpp
-     g++ -std=c++11 -o graph graph.cpp tests.cpp
\ No newline at end of file
+	g++ -std=c++11 -pthread -o graph graph.cpp tests.cpp
\ No newline at end of file
@@ -3,42 +3,68 @@
 #include "tests.h"
 
 
-bool dfs(vector<vector<int>>& adj_list, int source, int target) {
+void GraphWorkspace::reserve(int vertices, int edges) {
+    // Pre-size every buffer so that even the first call on a graph of this size avoids growth
+    stack.reserve(max(vertices, edges) + 1);
+    queue.reserve(vertices);
+    heap.reserve(edges + 1);
+    dist.reserve(vertices);
+    cursor.reserve(vertices);
+    order.reserve(max(vertices, edges) + 1);
+    visited.reserve(vertices);
+    onStack.reserve(vertices);
+}
+
+template <typename Graph>
+static bool dfsImpl(Graph& adj_list, int source, int target, GraphWorkspace* ws) {
     // Finds if a node can be reached from the source in O(V) time   
     int n = adj_list.size();
+    GraphWorkspace local;
+    if (!ws) ws = &local;
 
-    stack<int> s;
-    s.push(source);
-    vector<bool> visited(n,false);
+    vector<int>& s = ws->stack;
+    s.clear();
+    s.push_back(source);
+    vector<bool>& visited = ws->visited;
+    visited.assign(n,false);
 
     while (!s.empty()) {
-        auto t = s.top();
+        auto t = s.back();
         if (t == target) return true; // found
-        s.pop();
+        s.pop_back();
         visited[t] = true;
         for (auto v: adj_list[t]) {
-            if (!visited[v]) s.push(v);
+            if (!visited[v]) s.push_back(v);
         }
     }
     return false; // not found
 }
 
-int bfs(vector<vector<int>>& adj_list, int source, int target) {
+bool dfs(vector<vector<int>>& adj_list, int source, int target, GraphWorkspace* ws) {
+    return dfsImpl(adj_list, source, target, ws);
+}
+
+template <typename Graph>
+static int bfsImpl(Graph& adj_list, int source, int target, GraphWorkspace* ws) {
     // Finds the fewest edges required to reach a target node from the source in O(V) time
     int n = adj_list.size();
+    GraphWorkspace local;
+    if (!ws) ws = &local;
 
-    queue<int> q;
-    q.push(source);
-    vector<int> length(n,-1);
+    // Every vertex is enqueued at most once, so a flat vector with a head index is enough
+    vector<int>& q = ws->queue;
+    q.clear();
+    q.push_back(source);
+    vector<int>& length = ws->dist;
+    length.assign(n,-1);
     length[source] = 0;
 
-    while (!q.empty()) {
-        auto f = q.front();
-        q.pop();
+    for (size_t head = 0; head < q.size(); head++) {
+        auto f = q[head];
         if (f == target) return length[f];
         for (auto v: adj_list[f]) {
             if (length[v] == -1) {
-                q.push(v);
+                q.push_back(v);
                 length[v] = length[f]+1; // adding path length
             }
         }
@@ -46,43 +72,59 @@ int bfs(vector<vector<int>>& adj_list, int source, int target) {
     return -1;
 }
 
-int djikstra(vector<vector<pii>>& adj_list, int source, int target) {
+int bfs(vector<vector<int>>& adj_list, int source, int target, GraphWorkspace* ws) {
+    return bfsImpl(adj_list, source, target, ws);
+}
+
+int djikstra(vector<vector<pii>>& adj_list, int source, int target, GraphWorkspace* ws) {
     // Finds the shortest path between vertices in a positively weighted graph in O(ElogV) time
     int n = adj_list.size();
+    GraphWorkspace local;
+    if (!ws) ws = &local;
 
-    priority_queue<pii, vector<pii>, greater<pii>> pq; // min heap
-    pq.push(mp(0,source));
-    vector<int> distances(n,INT32_MAX);
+    vector<pii>& pq = ws->heap; // min heap
+    pq.clear();
+    pq.push_back(mp(0,source));
+    vector<int>& distances = ws->dist;
+    distances.assign(n,INT32_MAX);
     distances[source] = 0;
 
     while (!pq.empty()) {
-        auto p = pq.top();
-        pq.pop();
+        pop_heap(pq.begin(), pq.end(), greater<pii>());
+        auto p = pq.back();
+        pq.pop_back();
         if (p.second == target) return distances[target];
         for (auto v: adj_list[p.second]) {
             if (distances[p.second] + v.second < distances[v.first]) { // new best found
                 distances[v.first] = distances[p.second] + v.second;
-                pq.push(mp(distances[v.first], v.first));
+                pq.push_back(mp(distances[v.first], v.first));
+                push_heap(pq.begin(), pq.end(), greater<pii>());
             }
         }
     }
     return -1; // no path
 }
 
-bool cycleDetect(vector<vector<int>>& adj_list) {
+template <typename Graph>
+static bool cycleDetectImpl(Graph& adj_list, GraphWorkspace* ws) {
     // Returns whether or not the graph contains a cycle in O(V) time
     // Works for both directed and undirected graphs by finding back edges (but I coded it for directed)
     int n = adj_list.size();
+    GraphWorkspace local;
+    if (!ws) ws = &local;
 
-    stack<int> s;
-    vector<bool> onStack(n,false);
-    vector<bool> visited(n,false);
+    vector<int>& s = ws->stack;
+    s.clear();
+    vector<bool>& onStack = ws->onStack;
+    onStack.assign(n,false);
+    vector<bool>& visited = ws->visited;
+    visited.assign(n,false);
     bool deadEnd;
 
     for (int i = 0; i < n; i++) {
-        if (!visited[i]) s.push(i);
+        if (!visited[i]) s.push_back(i);
         while (!s.empty()) {
-            auto t = s.top();
+            auto t = s.back();
             onStack[t] = true;
             visited[t] = true;
             deadEnd = true;
@@ -90,11 +132,11 @@ bool cycleDetect(vector<vector<int>>& adj_list) {
                 if (onStack[v]) return true;
                 else if (!visited[v]) {
                     deadEnd = false;
-                    s.push(v);
+                    s.push_back(v);
                 }
             }
             if (deadEnd) {
-                s.pop();
+                s.pop_back();
                 onStack[t] = false;
             }
         }
@@ -102,71 +144,91 @@ bool cycleDetect(vector<vector<int>>& adj_list) {
     return false;
 }
 
-vector<int> topologicalSort(vector<vector<int>>& adj_list) {
+bool cycleDetect(vector<vector<int>>& adj_list, GraphWorkspace* ws) {
+    return cycleDetectImpl(adj_list, ws);
+}
+
+template <typename Graph>
+static vector<int> topologicalSortImpl(Graph& adj_list, GraphWorkspace* ws) {
     // Returns a valid topological sorting of a directed acyclic graph (DAG) in O(V) time
     // Useful for dependency relationships or prerequisites
     int n = adj_list.size();
+    GraphWorkspace local;
+    if (!ws) ws = &local;
 
-    stack<int> sortStack;
-    vector<bool> included(n,false);
-    vector<bool> onStack(n,false); // for cycles
-    stack<int> s;
+    vector<int>& sortStack = ws->order;
+    sortStack.clear();
+    vector<bool>& included = ws->visited;
+    included.assign(n,false);
+    vector<bool>& onStack = ws->onStack; // for cycles
+    onStack.assign(n,false);
+    vector<int>& s = ws->stack;
+    s.clear();
     bool deadEnd;
 
     for (int i = 0; i < n; i++) {
         if (!included[i]) {
-            s.push(i);
+            s.push_back(i);
             while (!s.empty()) {
-                auto t = s.top();
+                auto t = s.back();
                 onStack[t] = true;
                 deadEnd = true;
                 for (auto v: adj_list[t]) {
                     if (onStack[v]) return {}; // indicative of cycle
                     else if (!included[v]) {
                         deadEnd = false;
-                        s.push(v);
+                        s.push_back(v);
                     }
                 }
                 if (deadEnd) { // reached an endpoint
-                    s.pop();
+                    s.pop_back();
                     onStack[t] = false;                   
-                    if (!included[t]) sortStack.push(t);
+                    if (!included[t]) sortStack.push_back(t);
                     included[t] = true;
                 }
             }
         }
     }
 
-    vector<int> sorted;
-    while (!sortStack.empty()) {
-        sorted.push_back(sortStack.top());
-        sortStack.pop();
-    }
-    return sorted;
+    return vector<int>(sortStack.rbegin(), sortStack.rend());
 }
 
+vector<int> topologicalSort(vector<vector<int>>& adj_list, GraphWorkspace* ws) {
+    return topologicalSortImpl(adj_list, ws);
+}
 
-int prim(vector<vector<pii>>& adj_list) {
+
+static int primFrom(vector<vector<pii>>& adj_list, int start, GraphWorkspace* ws) {
     // Returns a MST of the graph in O(ElogV) time
     // If graph is disconnected return -1
     int n = adj_list.size();
+    GraphWorkspace local;
+    if (!ws) ws = &local;
 
-    vector<bool> inMst(n);
-    int start = 0;
+    vector<bool>& inMst = ws->visited;
+    inMst.assign(n,false);
     int included = 1;
     int cost = 0;
     inMst[start] = true;
-    priority_queue<pii, vector<pii>, greater<pii>> pq;
-    for (auto v: adj_list[start]) pq.push(mp(v.second, v.first));
+    vector<pii>& pq = ws->heap; // min heap
+    pq.clear();
+    for (auto v: adj_list[start]) {
+        pq.push_back(mp(v.second, v.first));
+        push_heap(pq.begin(), pq.end(), greater<pii>());
+    }
 
     while (included != n && !pq.empty()) {
-        auto p = pq.top();
-        pq.pop();
+        pop_heap(pq.begin(), pq.end(), greater<pii>());
+        auto p = pq.back();
+        pq.pop_back();
         if (!inMst[p.second]) { // add to mst
             cost += p.first;
             included++;
             inMst[p.second] = true;
-            for (auto v: adj_list[p.second]) pq.push(mp(v.second, v.first));
+            for (auto v: adj_list[p.second]) {
+                pq.push_back(mp(v.second, v.first));
+                push_heap(pq.begin(), pq.end(), greater<pii>());
+            }
         }
     }
 
@@ -174,12 +236,19 @@ int prim(vector<vector<pii>>& adj_list) {
     return cost;
 }
 
-int bellmanFord(vector<vector<pii>>& adj_list, int source, int target) {
+int prim(vector<vector<pii>>& adj_list, GraphWorkspace* ws) {
+    return primFrom(adj_list, 0, ws);
+}
+
+int bellmanFord(vector<vector<pii>>& adj_list, int source, int target, GraphWorkspace* ws) {
     // Shortest path in a graph with negative edge weights in O(VE) time
     // Also applicable for "weird" pathfinding, for example you get to cut out one edge
     int n = adj_list.size();
+    GraphWorkspace local;
+    if (!ws) ws = &local;
 
-    vector<int> distances(n, INT32_MAX);
+    vector<int>& distances = ws->dist;
+    distances.assign(n, INT32_MAX);
     distances[source] = 0;
 
     for (int i = 0; i < n-1; i++) { // V-1 relaxations
@@ -228,65 +297,699 @@ vector<vector<int>> floydWarshall(vector<vector<pii>>& adj_list) {
     // Note: if all weights are positive, then can just do V iterations of Djikstra at VElogV if E ~= V
 }
 
-vector<int> hierholzerEulerian(vector<vector<int>> adj_list) {
-    // Finds the Eulerian path/cycle in a directed graph in O(V+E) time
-    // Eulerian path/cycle traverses all edges exactly once (with the cycle ending at start vertex)
-
+template <typename Graph>
+static bool eulerianStart(Graph& adj_list, vector<int>& degree, int balancedStart, int& start) {
+    // Check if graph is Eulerian - either all zero degree (cyclic) or one (1,-1) pair
+    // A cycle starts at balancedStart, a path at its (1) vertex
     int n = adj_list.size();
-
-    vector<int> degree(n);
-    int start = 0;
+    degree.assign(n,0);
+    start = balancedStart;
     int end = 0;
 
-    // Check if graph is Eulerian - either all zero degree (cyclic) or one (1,-1) pair
     for (int i = 0; i < n; i++) {
-        for (int v: adj_list[i]) degree[v]--;
-        degree[i] += adj_list[i].size();
+        for (int v: adj_list[i]) {
+            degree[v]--;
+            degree[i]++;
+        }
     }
     bool oneFlag = false;
     bool minusFlag = false;
     for (int i = 0; i < n; i++) {
-        if (abs(degree[i]) > 1) return {};
+        if (abs(degree[i]) > 1) return false;
         else if (degree[i] == 1) {
-            if (oneFlag) return {};
+            if (oneFlag) return false;
             else {
                 oneFlag = true;
                 start = i;
             }
         }
         else if (oneFlag == -1) {
-            if (minusFlag) return {};
+            if (minusFlag) return false;
             else {
                 minusFlag = true;
                 end = i;
             }
         }
     }
+    return true;
+}
+
+static vector<int> hierholzerFrom(vector<vector<int>>& adj_list, int balancedStart, GraphWorkspace* ws) {
+    // Finds the Eulerian path/cycle in a directed graph in O(V+E) time
+    // Eulerian path/cycle traverses all edges exactly once (with the cycle ending at start vertex)
+
+    int n = adj_list.size();
+    GraphWorkspace local;
+    if (!ws) ws = &local;
+
+    int start;
+    if (!eulerianStart(adj_list, ws->dist, balancedStart, start)) return {};
+
+    // Edges are consumed from the back of each list through a cursor instead of popping,
+    // so the graph is left untouched and never copied
+    vector<int>& remaining = ws->cursor;
+    remaining.resize(n);
+    for (int i = 0; i < n; i++) remaining[i] = adj_list[i].size();
 
     // Find the Euler path using dfs
-    stack<int> dfs;
-    dfs.push(start);
-    vector<int> euler = {};
+    vector<int>& dfs = ws->stack;
+    dfs.clear();
+    dfs.push_back(start);
+    vector<int>& euler = ws->order;
+    euler.clear();
 
     while (!dfs.empty()) {
-        int t = dfs.top();
-        if (!adj_list[t].empty()) {
-            dfs.push(adj_list[t].back());
-            adj_list[t].pop_back();
+        int t = dfs.back();
+        if (remaining[t] > 0) {
+            dfs.push_back(adj_list[t][--remaining[t]]);
         }
         else {
             euler.push_back(t);
-            dfs.pop();
+            dfs.pop_back();
+        }
+    }
+
+    return vector<int>(euler.rbegin(), euler.rend());
+}
+
+vector<int> hierholzerEulerian(vector<vector<int>>& adj_list, GraphWorkspace* ws) {
+    return hierholzerFrom(adj_list, 0, ws);
+}
+
+
+
+// Cache-locality reordering
+
+static vector<vector<int>> undirectedView(vector<vector<int>>& adj_list) {
+    // Out- and in-neighbours together; locality heuristics care about both directions
+    int n = adj_list.size();
+    vector<vector<int>> sym(n);
+    for (int i = 0; i < n; i++) {
+        for (int v: adj_list[i]) {
+            sym[i].push_back(v);
+            sym[v].push_back(i);
+        }
+    }
+    return sym;
+}
+
+static vector<int> verticesByDegree(vector<vector<int>>& sym, bool ascending) {
+    // Ties keep their original order so every ordering is deterministic
+    vector<int> byDegree(sym.size());
+    for (int i = 0; i < (int)sym.size(); i++) byDegree[i] = i;
+    stable_sort(byDegree.begin(), byDegree.end(), [&](int a, int b) {
+        return ascending ? sym[a].size() < sym[b].size() : sym[a].size() > sym[b].size();
+    });
+    return byDegree;
+}
+
+static vector<int> reverseCuthillMcKee(vector<vector<int>>& sym) {
+    // BFS from a low-degree vertex of each component, visiting neighbours by increasing degree
+    int n = sym.size();
+    vector<int> order;
+    vector<bool> visited(n,false);
+    vector<int> next;
+
+    for (int s: verticesByDegree(sym, true)) {
+        if (visited[s]) continue;
+        visited[s] = true;
+        size_t head = order.size();
+        order.push_back(s);
+        for (; head < order.size(); head++) {
+            next.clear();
+            for (int v: sym[order[head]]) {
+                if (!visited[v]) {
+                    visited[v] = true;
+                    next.push_back(v);
+                }
+            }
+            stable_sort(next.begin(), next.end(), [&](int a, int b) { return sym[a].size() < sym[b].size(); });
+            order.insert(order.end(), next.begin(), next.end());
         }
     }
 
-    reverse(euler.begin(), euler.end());
+    reverse(order.begin(), order.end());
+    return order;
+}
+
+static vector<int> hubCluster(vector<vector<int>>& sym) {
+    // Packs the above-average-degree hubs together at the front, everything else keeps its order
+    int n = sym.size();
+    long long total = 0;
+    for (auto& nbrs: sym) total += nbrs.size();
+    vector<int> order;
+    for (int i = 0; i < n; i++) if ((long long)sym[i].size() * n > total) order.push_back(i);
+    for (int i = 0; i < n; i++) if ((long long)sym[i].size() * n <= total) order.push_back(i);
+    return order;
+}
+
+static vector<int> gorderWindow(vector<vector<int>>& sym, int window) {
+    // Greedy Gorder: repeatedly place the vertex sharing the most neighbours and siblings
+    // with the last `window` placed vertices. Scores live in a lazy max-heap: increments
+    // push a fresh entry, decrements push nothing and the stale entry is re-pushed with
+    // the right score when it surfaces. Hubs are skipped when spreading sibling scores,
+    // which would otherwise cost O(deg^2) per hub.
+    int n = sym.size();
+    const size_t hubCap = 16;
+    vector<int> order;
+    vector<bool> placed(n,false);
+    vector<int> score(n,0);
+    vector<pii> heap;
+    vector<int> frontier; // neighbours of placed vertices, most recent last
+
+    auto bump = [&](int u, int delta) {
+        if (placed[u]) return;
+        score[u] += delta;
+        if (delta > 0) {
+            heap.push_back(mp(score[u], u));
+            push_heap(heap.begin(), heap.end());
+        }
+    };
+    auto spread = [&](int v, int delta) {
+        for (int u: sym[v]) {
+            bump(u, delta);
+            if (sym[u].size() > hubCap) continue;
+            for (int w: sym[u]) if (w != v) bump(w, delta);
+        }
+    };
+
+    vector<int> seeds = verticesByDegree(sym, false);
+    size_t nextSeed = 0;
+    while ((int)order.size() < n) {
+        int v = -1;
+        while (!heap.empty() && v == -1) {
+            pop_heap(heap.begin(), heap.end());
+            auto top = heap.back();
+            heap.pop_back();
+            int u = top.second;
+            if (placed[u] || score[u] <= 0) continue;
+            if (top.first == score[u]) v = u;
+            else if (top.first > score[u]) { // decremented since this entry was pushed
+                heap.push_back(mp(score[u], u));
+                push_heap(heap.begin(), heap.end());
+            }
+        }
+        // Nothing related to the window: continue next to what was placed last, so the
+        // order does not scatter, and only then start again from the biggest hub left
+        while (v == -1 && !frontier.empty()) {
+            if (!placed[frontier.back()]) v = frontier.back();
+            frontier.pop_back();
+        }
+        if (v == -1) {
+            while (placed[seeds[nextSeed]]) nextSeed++;
+            v = seeds[nextSeed];
+        }
+
+        placed[v] = true;
+        order.push_back(v);
+        for (int u: sym[v]) if (!placed[u]) frontier.push_back(u);
+        spread(v, 1);
+        if ((int)order.size() > window) spread(order[order.size()-1-window], -1);
+    }
+    return order;
+}
+
+vector<int> reorderPermutation(vector<vector<int>>& adj_list, ReorderMethod method) {
+    // Returns the original vertices in their new order, i.e. the relabelled ID -> original ID map
+    vector<vector<int>> sym = undirectedView(adj_list);
+    switch (method) {
+        case RCM: return reverseCuthillMcKee(sym);
+        case DEGREE_SORT: return verticesByDegree(sym, false);
+        case HUB_CLUSTER: return hubCluster(sym);
+        case GORDER: return gorderWindow(sym, 5);
+    }
+    return {};
+}
+
+static vector<int> invert(vector<int>& perm) {
+    vector<int> inverse(perm.size());
+    for (int i = 0; i < (int)perm.size(); i++) inverse[perm[i]] = i;
+    return inverse;
+}
+
+ReorderedGraph reorder(vector<vector<int>>& adj_list, ReorderMethod method) {
+    // Relabels the graph, keeping every neighbour list in its original order
+    int n = adj_list.size();
+    ReorderedGraph g;
+    g.oldId = reorderPermutation(adj_list, method);
+    g.newId = invert(g.oldId);
+    g.adj_list.resize(n);
+    for (int i = 0; i < n; i++) {
+        auto& nbrs = g.adj_list[i];
+        for (int v: adj_list[g.oldId[i]]) nbrs.push_back(g.newId[v]);
+    }
+    return g;
+}
+
+ReorderedWeightedGraph reorder(vector<vector<pii>>& adj_list, ReorderMethod method) {
+    // The permutation only depends on the topology, weights just follow their edges
+    int n = adj_list.size();
+    vector<vector<int>> topology(n);
+    for (int i = 0; i < n; i++) {
+        for (auto e: adj_list[i]) topology[i].push_back(e.first);
+    }
+
+    ReorderedWeightedGraph g;
+    g.oldId = reorderPermutation(topology, method);
+    g.newId = invert(g.oldId);
+    g.adj_list.resize(n);
+    for (int i = 0; i < n; i++) {
+        auto& nbrs = g.adj_list[i];
+        for (auto e: adj_list[g.oldId[i]]) nbrs.push_back(mp(g.newId[e.first], e.second));
+    }
+    return g;
+}
+
+double averageNeighborGap(vector<vector<int>>& adj_list) {
+    // Mean |u - v| over all edges u -> v; smaller means neighbour scans stay closer in memory
+    long long total = 0, edges = 0;
+    for (int i = 0; i < (int)adj_list.size(); i++) {
+        for (int v: adj_list[i]) total += abs(v - i);
+        edges += adj_list[i].size();
+    }
+    return edges ? (double)total / edges : 0;
+}
+
+double averageNeighborGap(vector<vector<pii>>& adj_list) {
+    long long total = 0, edges = 0;
+    for (int i = 0; i < (int)adj_list.size(); i++) {
+        for (auto e: adj_list[i]) total += abs(e.first - i);
+        edges += adj_list[i].size();
+    }
+    return edges ? (double)total / edges : 0;
+}
+
+bool dfs(ReorderedGraph& g, int source, int target, GraphWorkspace* ws) {
+    return dfs(g.adj_list, g.newId[source], g.newId[target], ws);
+}
+
+int bfs(ReorderedGraph& g, int source, int target, GraphWorkspace* ws) {
+    return bfs(g.adj_list, g.newId[source], g.newId[target], ws);
+}
+
+bool cycleDetect(ReorderedGraph& g, GraphWorkspace* ws) {
+    return cycleDetect(g.adj_list, ws);
+}
+
+vector<int> topologicalSort(ReorderedGraph& g, GraphWorkspace* ws) {
+    vector<int> sorted = topologicalSort(g.adj_list, ws);
+    for (auto& v: sorted) v = g.oldId[v];
+    return sorted;
+}
+
+vector<int> hierholzerEulerian(ReorderedGraph& g, GraphWorkspace* ws) {
+    // A circuit starts where it would on the original graph, at original vertex 0
+    vector<int> euler = hierholzerFrom(g.adj_list, g.newId.empty() ? 0 : g.newId[0], ws);
+    for (auto& v: euler) v = g.oldId[v];
     return euler;
 }
 
+int djikstra(ReorderedWeightedGraph& g, int source, int target, GraphWorkspace* ws) {
+    return djikstra(g.adj_list, g.newId[source], g.newId[target], ws);
+}
+
+int prim(ReorderedWeightedGraph& g, GraphWorkspace* ws) {
+    // Grow the tree from original vertex 0, which matters on directed graphs
+    return primFrom(g.adj_list, g.newId.empty() ? 0 : g.newId[0], ws);
+}
+
+int bellmanFord(ReorderedWeightedGraph& g, int source, int target, GraphWorkspace* ws) {
+    return bellmanFord(g.adj_list, g.newId[source], g.newId[target], ws);
+}
+
+// Compressed adjacency
+
+static void writeVarint(vector<unsigned char>& bytes, unsigned x) {
+    while (x >= 0x80) {
+        bytes.push_back((x & 0x7f) | 0x80);
+        x >>= 7;
+    }
+    bytes.push_back(x);
+}
+
+static unsigned zigzag(int x) {
+    return ((unsigned)x << 1) ^ (unsigned)(x >> 31);
+}
+
+static size_t varintSize(unsigned x) {
+    size_t size = 1;
+    for (; x >= 0x80; x >>= 7) size++;
+    return size;
+}
 
+CompressedGraphBuilder::CompressedGraphBuilder() : current(-1), previous(0), first(true), ok(true), minTarget(0), maxTarget(-1) {
+    openNextVertex();
+}
+
+void CompressedGraphBuilder::reserve(int vertices, size_t bytes) {
+    graph.offsets.reserve(vertices + 1);
+    graph.blockOffsets.reserve((vertices >> CompressedGraph::blockShift) + 1);
+    graph.bytes.reserve(bytes);
+}
+
+void CompressedGraphBuilder::openNextVertex() {
+    // Also used once past the last vertex, where the entry marks where the last list ends
+    current++;
+    if ((current & ((1 << CompressedGraph::blockShift) - 1)) == 0) graph.blockOffsets.push_back(graph.bytes.size());
+    size_t offset = graph.bytes.size() - graph.blockOffsets.back();
+    if (offset > UINT32_MAX) ok = false;
+    graph.offsets.push_back(offset);
+    previous = current;
+    first = true;
+}
+
+void CompressedGraphBuilder::addEdge(int source, int target) {
+    if (!ok) return;
+    if (source < current || (source == current && !first && target < previous)) {
+        ok = false;
+        return;
+    }
+    while (current < source) openNextVertex();
+
+    if (first) writeVarint(graph.bytes, zigzag(target - source));
+    else writeVarint(graph.bytes, target - previous);
+    previous = target;
+    first = false;
+    minTarget = min(minTarget, target);
+    maxTarget = max(maxTarget, target);
+    graph.edges++;
+}
+
+bool CompressedGraphBuilder::finish(int vertices, CompressedGraph& g) {
+    if (current >= vertices || minTarget < 0 || maxTarget >= vertices) ok = false;
+    while (ok && current < vertices) openNextVertex();
+    if (!ok) return false;
+    g = move(graph);
+    return true;
+}
+
+CompressedGraph compress(vector<vector<int>>& adj_list) {
+    // Convenience wrapper for a graph already in memory. Sorting makes every gap after the
+    // first non-negative and, on well-ordered graphs, small. A first pass sizes the byte
+    // stream exactly so it is allocated once.
+    int n = adj_list.size();
+    CompressedGraphBuilder builder;
+    vector<int> sorted;
+    size_t bytes = 0;
+
+    for (int i = 0; i < n; i++) {
+        sorted.assign(adj_list[i].begin(), adj_list[i].end());
+        sort(sorted.begin(), sorted.end());
+        for (int j = 0; j < (int)sorted.size(); j++) {
+            bytes += varintSize(j == 0 ? zigzag(sorted[0] - i) : sorted[j] - sorted[j-1]);
+        }
+    }
+    builder.reserve(n, bytes);
+
+    for (int i = 0; i < n; i++) {
+        sorted.assign(adj_list[i].begin(), adj_list[i].end());
+        sort(sorted.begin(), sorted.end());
+        for (int v: sorted) builder.addEdge(i, v);
+    }
 
-int main() {
+    CompressedGraph g;
+    bool built = builder.finish(n, g);
+    assert(built); // an adj_list is always in order, so only a >4GB block or a bad target fails
+    (void)built;
+    return g;
+}
+
+double bitsPerEdge(CompressedGraph& g) {
+    // Total storage: the neighbour stream plus both levels of the offset index
+    size_t bytes = g.bytes.size() + g.offsets.size() * sizeof(unsigned) + g.blockOffsets.size() * sizeof(size_t);
+    return g.edges ? 8.0 * bytes / g.edges : 0;
+}
+
+bool dfs(CompressedGraph& g, int source, int target, GraphWorkspace* ws) {
+    return dfsImpl(g, source, target, ws);
+}
+
+int bfs(CompressedGraph& g, int source, int target, GraphWorkspace* ws) {
+    return bfsImpl(g, source, target, ws);
+}
+
+bool cycleDetect(CompressedGraph& g, GraphWorkspace* ws) {
+    return cycleDetectImpl(g, ws);
+}
+
+vector<int> topologicalSort(CompressedGraph& g, GraphWorkspace* ws) {
+    return topologicalSortImpl(g, ws);
+}
+
+vector<int> hierholzerEulerian(CompressedGraph& g, GraphWorkspace* ws) {
+    // Same walk as on an adj_list, but compressed lists only decode forwards, so edges
+    // are consumed from the front: each vertex remembers the byte position of its next
+    // unused edge and the last neighbour it decoded, which the next gap is added to
+    int n = g.size();
+    GraphWorkspace local;
+    if (!ws) ws = &local;
+
+    int start;
+    if (!eulerianStart(g, ws->dist, 0, start)) return {};
+
+    vector<int>& position = ws->cursor;
+    position.assign(n,0);
+    vector<int>& previous = ws->dist; // degrees are no longer needed
+    for (int i = 0; i < n; i++) previous[i] = i;
+
+    vector<int>& dfs = ws->stack;
+    dfs.clear();
+    dfs.push_back(start);
+    vector<int>& euler = ws->order;
+    euler.clear();
+
+    while (!dfs.empty()) {
+        int t = dfs.back();
+        CompressedNeighbors nbrs = g[t];
+        const unsigned char* p = nbrs.first + position[t];
+        if (p != nbrs.last) {
+            unsigned code = readVarint(p);
+            if (position[t] == 0) previous[t] += unzigzag(code);
+            else previous[t] += code;
+            position[t] = p - nbrs.first;
+            dfs.push_back(previous[t]);
+        }
+        else {
+            euler.push_back(t);
+            dfs.pop_back();
+        }
+    }
+
+    return vector<int>(euler.rbegin(), euler.rend());
+}
+
+// Semi-external algorithms
+
+bool writeEdgeFile(vector<vector<int>>& adj_list, const string& path) {
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) return false;
+    int n = adj_list.size();
+    bool ok = fwrite(&n, sizeof(int), 1, f) == 1;
+    for (int i = 0; i < n && ok; i++) {
+        for (int v: adj_list[i]) {
+            int edge[2] = {i, v};
+            if (fwrite(edge, sizeof(int), 2, f) != 2) ok = false;
+        }
+    }
+    return fclose(f) == 0 && ok;
+}
+
+class EdgeStream {
+    // An edge file opened for one whole algorithm call. The two partition buffers are
+    // allocated once (never larger than the file) and a single reader thread fills one
+    // while the caller scatters the other.
+public:
+    EdgeStream(const string& path, size_t memoryBudget) {
+        f = fopen(path.c_str(), "rb");
+        if (!f) return;
+        if (fread(&n, sizeof(int), 1, f) != 1 || n < 0) {
+            fclose(f);
+            f = nullptr;
+            return;
+        }
+        fseek(f, 0, SEEK_END);
+        long long edges = (ftell(f) - (long long)sizeof(int)) / (long long)sizeof(pii);
+        size_t capacity = max<long long>(1, min<long long>(memoryBudget / (2 * sizeof(pii)), edges));
+        buffers[0].resize(capacity);
+        buffers[1].resize(capacity);
+        reader = thread(&EdgeStream::readLoop, this);
+    }
+
+    ~EdgeStream() {
+        if (!f) return;
+        {
+            lock_guard<mutex> lock(m);
+            stop = true;
+        }
+        wake.notify_all();
+        reader.join();
+        fclose(f);
+    }
+
+    bool ok() const { return f != nullptr; }
+    int vertices() const { return n; }
+
+    template <typename Scatter>
+    void pass(Scatter scatter) {
+        // One sequential pass over every edge
+        fseek(f, sizeof(int), SEEK_SET); // the reader is idle between passes
+        request(0);
+        size_t count = await();
+        for (int current = 0; count > 0; current ^= 1) {
+            request(current ^ 1);
+            for (size_t i = 0; i < count; i++) {
+                int u = buffers[current][i].first, v = buffers[current][i].second;
+                if (u >= 0 && u < n && v >= 0 && v < n) scatter(u, v);
+            }
+            count = await();
+        }
+    }
+
+private:
+    FILE* f = nullptr;
+    int n = 0;
+    vector<pii> buffers[2];
+    thread reader;
+    mutex m;
+    condition_variable wake;
+    int target = 0;       // buffer the reader should fill next
+    size_t filled = 0;    // edges it read into that buffer
+    bool pending = false;
+    bool done = false;
+    bool stop = false;
+
+    void request(int buffer) {
+        {
+            lock_guard<mutex> lock(m);
+            target = buffer;
+            pending = true;
+            done = false;
+        }
+        wake.notify_all();
+    }
+
+    size_t await() {
+        unique_lock<mutex> lock(m);
+        wake.wait(lock, [this]() { return done; });
+        return filled;
+    }
+
+    void readLoop() {
+        unique_lock<mutex> lock(m);
+        while (true) {
+            wake.wait(lock, [this]() { return pending || stop; });
+            if (stop) return;
+            pending = false;
+            vector<pii>& buffer = buffers[target];
+            lock.unlock();
+            size_t count = fread(buffer.data(), sizeof(pii), buffer.size(), f);
+            lock.lock();
+            filled = count;
+            done = true;
+            wake.notify_all();
+        }
+    }
+};
+
+int externalBfs(const string& path, int source, int target, size_t memoryBudget) {
+    // Fewest edges from source to target. Each pass relaxes every edge, so after k passes
+    // every vertex within k hops has its final length. A target length no larger than the
+    // number of passes made is therefore final, and the search stops after at most
+    // (shortest path length) passes; an unreachable target runs until nothing changes.
+    EdgeStream edges(path, memoryBudget);
+    if (!edges.ok()) return -1;
+    int n = edges.vertices();
+    if (source < 0 || source >= n || target < 0 || target >= n) return -1;
+
+    vector<int> length(n,-1);
+    length[source] = 0;
+    bool changed = true;
+
+    for (int passes = 0; changed; passes++) {
+        if (length[target] != -1 && passes >= length[target]) break;
+        changed = false;
+        edges.pass([&](int u, int v) {
+            if (length[u] != -1 && (length[v] == -1 || length[u]+1 < length[v])) {
+                length[v] = length[u]+1;
+                changed = true;
+            }
+        });
+    }
+
+    return length[target];
+}
+
+vector<int> externalComponents(const string& path, size_t memoryBudget) {
+    // Weakly connected components by label propagation: every vertex ends up labelled
+    // with the smallest vertex ID in its component
+    EdgeStream edges(path, memoryBudget);
+    if (!edges.ok()) return {};
+    int n = edges.vertices();
+
+    vector<int> label(n);
+    for (int i = 0; i < n; i++) label[i] = i;
+    bool changed = true;
+
+    while (changed) {
+        changed = false;
+        edges.pass([&](int u, int v) {
+            if (label[u] != label[v]) {
+                label[u] = label[v] = min(label[u], label[v]);
+                changed = true;
+            }
+        });
+    }
+
+    return label;
+}
+
+bool externalCycleDetect(const string& path, size_t memoryBudget, int* passes) {
+    // Peels vertices with no remaining in-edges; whatever cannot be peeled lies on or
+    // behind a cycle. Like cycleDetect, an undirected graph stored with both edge
+    // directions counts as cyclic. A vertex peeled at edge i of a pass has its later
+    // out-edges released in that same pass and the rest (at or before i) in the next,
+    // so peeling cascades down the file and a DAG stored in source order takes one pass.
+    if (passes) *passes = 0;
+    EdgeStream edges(path, memoryBudget);
+    if (!edges.ok()) return false;
+    int n = edges.vertices();
+
+    vector<int> inDegree(n,0);
+    edges.pass([&](int, int v) { inDegree[v]++; });
+    int made = 1;
+
+    vector<int> peeledPass(n,0);        // pass a vertex was peeled in, 0 while it is still there
+    vector<long long> peeledAt(n,-1);   // edge index it was peeled at, -1 if before the pass
+    int peeled = 0;
+    for (int i = 0; i < n; i++) {
+        if (inDegree[i] == 0) {
+            peeledPass[i] = 1;
+            peeled++;
+        }
+    }
+    for (int round = 1; peeled < n; round++) {
+        int before = peeled;
+        long long index = 0;
+        edges.pass([&](int u, int v) {
+            long long i = index++;
+            if ((peeledPass[u] == round && i > peeledAt[u]) || (peeledPass[u] == round-1 && i <= peeledAt[u])) {
+                if (--inDegree[v] == 0) {
+                    peeledPass[v] = round;
+                    peeledAt[v] = i;
+                    peeled++;
+                }
+            }
+        });
+        made++;
+        // Nothing new means every peeled vertex has released all of its out-edges
+        if (peeled == before) break;
+    }
+
+    if (passes) *passes = made;
+    return peeled != n;
+}
+
+int main(int argc, char** argv) {
     // Undirected graph 1 (dfs/bfs/cycleDetect)
     vector<vector<int>> u1  = {
         {1},
@@ -424,6 +1127,7 @@ int main() {
     vector<vector<vector<int>>> uwtests_l = {u1,u2,u3,d1,d2,d3};
     vector<vector<vector<pii>>> wtests_l = {wu1,wu2,wd1};
     vector<vector<vector<int>>> htests = {d1,d2,d4};
+    vector<vector<vector<int>>> wstests = {u1,u2,u3,d1,d2,d3,d4};
     
     // Basic
     testDFS(uwtests); // O(V+E)
@@ -440,5 +1144,23 @@ int main() {
     testFlWa(wtests_l); // O(V^3)
     testHierholzer(htests); // O(V+E)
 
+    // Reusable scratch buffers
+    testWorkspace(wstests, wtests_l);
+
+    // Cache-locality reordering
+    testReorder(wstests, wtests_l);
+
+    // Compressed adjacency
+    testCompressed(wstests);
+
+    // Semi-external (edges streamed from disk)
+    testExternal(wstests);
+
+    // Benchmarks are slow, run them with `./graph bench`
+    if (argc > 1 && string(argv[1]) == "bench") {
+        benchReorder();
+        benchCompressed();
+    }
+
     // Tarjan and Flow done in Python!
 }
\ No newline at end of file
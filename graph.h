@@ -4,6 +4,7 @@
  * A thorough exploration of 22 graph algorithms
  * */
 
+#pragma once
 #include <iostream>
 #include <string>
 #include <vector>
@@ -14,27 +15,53 @@
 #include <map>
 #include <queue>
 #include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 #define pii pair<int, int>
 #define mp make_pair
 
 using namespace std;
 
+// 0. Workspace
+/**
+ * Scratch buffers shared between algorithm calls. Pass the same workspace to
+ * repeated calls and, once its buffers have grown to fit the graph, no call
+ * allocates on the heap (apart from the vector an algorithm returns).
+ * Stacks, queues and heaps are all flat vectors: push_back/pop_back,
+ * a head index, and push_heap/pop_heap respectively.
+ * */
+struct GraphWorkspace {
+    vector<int> stack;
+    vector<int> queue;
+    vector<pii> heap;
+    vector<int> dist;
+    vector<int> cursor;
+    vector<int> order;
+    vector<bool> visited;
+    vector<bool> onStack;
+
+    void reserve(int vertices, int edges);
+};
+
 // 1. Basic
-bool dfs(vector<vector<int>>& adj_list, int source, int target);
-int bfs(vector<vector<int>>& adj_list, int source, int target);
-int djikstra(vector<vector<pii>>& adj_list, int source, int target);
-bool cycleDetect(vector<vector<int>>& adj_list);
-vector<int> topologicalSort(vector<vector<int>>& adj_list);
+bool dfs(vector<vector<int>>& adj_list, int source, int target, GraphWorkspace* ws = nullptr);
+int bfs(vector<vector<int>>& adj_list, int source, int target, GraphWorkspace* ws = nullptr);
+int djikstra(vector<vector<pii>>& adj_list, int source, int target, GraphWorkspace* ws = nullptr);
+bool cycleDetect(vector<vector<int>>& adj_list, GraphWorkspace* ws = nullptr);
+vector<int> topologicalSort(vector<vector<int>>& adj_list, GraphWorkspace* ws = nullptr);
 
 // 2. Intermediate
 
 // 2.1 Minimum Spanning Trees
-int prim(vector<vector<pii>>& adj_list);
+int prim(vector<vector<pii>>& adj_list, GraphWorkspace* ws = nullptr);
 
 // 2.2 Advanced Path Finders
-int bellmanFord(vector<vector<pii>>& adj_list, int source, int target);
-vector<int> hierholzerEulerian(vector<vector<int>> adj_list);
+int bellmanFord(vector<vector<pii>>& adj_list, int source, int target, GraphWorkspace* ws = nullptr);
+vector<int> hierholzerEulerian(vector<vector<int>>& adj_list, GraphWorkspace* ws = nullptr);
 vector<vector<int>> floydWarshall(vector<vector<pii>>& adj_list);
 
 // 2.3: Tarjan Derivatives (done in Python)
@@ -47,4 +74,154 @@ vector<vector<int>> floydWarshall(vector<vector<pii>>& adj_list);
  * Max-flow min-cut problem, maximum bipartite matching
  */
 
-// 3. Advanced (NP-hard) done in Python
\ No newline at end of file
+// 3. Advanced (NP-hard) done in Python
+
+// 4. Preprocessing
+
+// 4.1 Cache-locality reordering
+/**
+ * Relabels vertices so that neighbours get nearby IDs and neighbour scans touch
+ * fewer cache lines. The algorithm overloads on a reordered graph take and
+ * return original vertex IDs, so callers never see the new labels.
+ * */
+enum ReorderMethod { RCM, DEGREE_SORT, HUB_CLUSTER, GORDER };
+
+struct ReorderedGraph {
+    vector<vector<int>> adj_list; // relabelled graph
+    vector<int> newId;            // original ID -> relabelled ID
+    vector<int> oldId;            // relabelled ID -> original ID
+};
+
+struct ReorderedWeightedGraph {
+    vector<vector<pii>> adj_list;
+    vector<int> newId;
+    vector<int> oldId;
+};
+
+vector<int> reorderPermutation(vector<vector<int>>& adj_list, ReorderMethod method);
+ReorderedGraph reorder(vector<vector<int>>& adj_list, ReorderMethod method);
+ReorderedWeightedGraph reorder(vector<vector<pii>>& adj_list, ReorderMethod method);
+double averageNeighborGap(vector<vector<int>>& adj_list);
+double averageNeighborGap(vector<vector<pii>>& adj_list);
+
+bool dfs(ReorderedGraph& g, int source, int target, GraphWorkspace* ws = nullptr);
+int bfs(ReorderedGraph& g, int source, int target, GraphWorkspace* ws = nullptr);
+bool cycleDetect(ReorderedGraph& g, GraphWorkspace* ws = nullptr);
+vector<int> topologicalSort(ReorderedGraph& g, GraphWorkspace* ws = nullptr);
+vector<int> hierholzerEulerian(ReorderedGraph& g, GraphWorkspace* ws = nullptr);
+int djikstra(ReorderedWeightedGraph& g, int source, int target, GraphWorkspace* ws = nullptr);
+int prim(ReorderedWeightedGraph& g, GraphWorkspace* ws = nullptr);
+int bellmanFord(ReorderedWeightedGraph& g, int source, int target, GraphWorkspace* ws = nullptr);
+
+// 4.2 Compressed adjacency
+/**
+ * Read-only graph storing each vertex's sorted neighbour list as varint gaps: the
+ * first neighbour relative to the vertex itself (zigzag-encoded, as it may be
+ * smaller), every later one relative to the previous neighbour. Indexing a vertex
+ * gives a range that decodes neighbours on the fly, so traversals never
+ * materialise a list and `for (auto v: g[t])` works just like on an adj_list.
+ * */
+inline unsigned readVarint(const unsigned char*& p) {
+    // Seven bits per byte, high bit set on every byte but the last
+    unsigned x = *p++;
+    if (x < 0x80) return x; // most gaps fit one byte
+    x &= 0x7f;
+    for (int shift = 7;; shift += 7) {
+        unsigned b = *p++;
+        x |= (b & 0x7f) << shift;
+        if (b < 0x80) return x;
+    }
+}
+
+inline int unzigzag(unsigned x) {
+    return (int)(x >> 1) ^ -(int)(x & 1);
+}
+
+struct CompressedNeighbors {
+    const unsigned char* first;
+    const unsigned char* last;
+    int vertex;
+
+    struct iterator {
+        const unsigned char* p;
+        const unsigned char* end;
+        int value;
+        bool done;
+
+        iterator(const unsigned char* p, const unsigned char* end, int vertex) : p(p), end(end), value(vertex), done(p == end) {
+            if (!done) value += unzigzag(readVarint(this->p));
+        }
+        int operator*() const { return value; }
+        iterator& operator++() {
+            if (p == end) done = true;
+            else value += readVarint(p);
+            return *this;
+        }
+        bool operator!=(const iterator& other) const { return p != other.p || done != other.done; }
+    };
+
+    iterator begin() const { return iterator(first, last, vertex); }
+    iterator end() const { return iterator(last, last, vertex); }
+};
+
+struct CompressedGraph {
+    // Vertex v's encoded neighbours start at byte blockOffsets[v / 64] + offsets[v]: a
+    // 64-bit base per block of 64 vertices keeps the per-vertex index at 32 bits
+    static const int blockShift = 6;
+    vector<size_t> blockOffsets;
+    vector<unsigned> offsets;
+    vector<unsigned char> bytes;
+    long long edges = 0;
+
+    size_t size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    const unsigned char* start(int v) const { return bytes.data() + blockOffsets[v >> blockShift] + offsets[v]; }
+    CompressedNeighbors operator[](int v) const { return {start(v), start(v+1), v}; }
+};
+
+/**
+ * Builds a CompressedGraph from edges streamed in (source, target) order, so the
+ * graph never has to exist uncompressed. reserve() with the final sizes keeps the
+ * byte stream from regrowing. finish() returns false if an edge arrived out of order,
+ * an endpoint lies outside [0, vertices), or 64 vertices need over 4GB of neighbours.
+ * */
+struct CompressedGraphBuilder {
+    CompressedGraphBuilder();
+    void reserve(int vertices, size_t bytes);
+    void addEdge(int source, int target);
+    bool finish(int vertices, CompressedGraph& g);
+
+private:
+    CompressedGraph graph;
+    int current;  // vertex whose list is being written
+    int previous; // last neighbour written, or the vertex itself before its first
+    bool first;
+    bool ok;
+    int minTarget;
+    int maxTarget;
+
+    void openNextVertex();
+};
+
+CompressedGraph compress(vector<vector<int>>& adj_list); // asserts the graph fits the index
+double bitsPerEdge(CompressedGraph& g);
+
+bool dfs(CompressedGraph& g, int source, int target, GraphWorkspace* ws = nullptr);
+int bfs(CompressedGraph& g, int source, int target, GraphWorkspace* ws = nullptr);
+bool cycleDetect(CompressedGraph& g, GraphWorkspace* ws = nullptr);
+vector<int> topologicalSort(CompressedGraph& g, GraphWorkspace* ws = nullptr);
+vector<int> hierholzerEulerian(CompressedGraph& g, GraphWorkspace* ws = nullptr);
+
+// 4.3 Semi-external algorithms
+/**
+ * For graphs whose edges do not fit in RAM. The edges live in a binary file (the
+ * vertex count, then one (source, target) int pair per edge) and every pass
+ * streams it sequentially in partitions, X-Stream style: per-vertex state stays in
+ * memory, edges never do. Two partition buffers share `memoryBudget` bytes and the
+ * next one is read in the background while the current one is scattered.
+ * An unreadable file, a negative vertex count or an out-of-range source/target
+ * gives -1, {} and false respectively; edges with endpoints outside [0, n) are ignored.
+ * */
+bool writeEdgeFile(vector<vector<int>>& adj_list, const string& path);
+int externalBfs(const string& path, int source, int target, size_t memoryBudget);
+vector<int> externalComponents(const string& path, size_t memoryBudget);
+bool externalCycleDetect(const string& path, size_t memoryBudget, int* passes = nullptr); // passes over the file
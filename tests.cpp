@@ -6,6 +6,51 @@
  * */
 
 #include "tests.h"
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <random>
+
+// Every global heap allocation is counted so the workspace tests can check that
+// steady-state calls never reach the allocator
+static long long allocations = 0;
+
+void* operator new(size_t size) {
+    allocations++;
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+
+void* operator new(size_t size, const nothrow_t&) noexcept {
+    allocations++;
+    return malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new[](size_t size, const nothrow_t& tag) noexcept {
+    return operator new(size, tag);
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, const nothrow_t&) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p, const nothrow_t&) noexcept {
+    free(p);
+}
 
 // Basic tests
 void testDFS(vector<vector<vector<int>>>& graphs) {
@@ -212,4 +257,574 @@ void testFlWa(vector<vector<vector<pii>>>& graphs) {
     }
 
     cout << "Done Floyd Warshall tests!" << endl << endl;
-}
\ No newline at end of file
+}
+
+// Workspace tests
+void testWorkspace(vector<vector<vector<int>>>& graphs, vector<vector<vector<pii>>>& wgraphs) {
+    cout << "Starting Workspace tests..." << endl;
+
+    GraphWorkspace ws;
+    long long dfsAllocs = 0, bfsAllocs = 0, cycleAllocs = 0, topAllocs = 0, eulerAllocs = 0;
+    long long djikAllocs = 0, primAllocs = 0, befoAllocs = 0;
+    bool sameAnswers = true;
+
+    // Warm up once so every buffer reaches its steady-state size, then count a second round
+    for (int round = 0; round < 2; round++) {
+        for (auto& g: graphs) {
+            int n = g.size();
+            long long before = allocations;
+            bool reached = dfs(g, 0, n-1, &ws);
+            if (round) dfsAllocs += allocations - before;
+            sameAnswers = sameAnswers && reached == dfs(g, 0, n-1);
+
+            before = allocations;
+            int len = bfs(g, 0, n-1, &ws);
+            if (round) bfsAllocs += allocations - before;
+            sameAnswers = sameAnswers && len == bfs(g, 0, n-1);
+
+            before = allocations;
+            bool cyclic = cycleDetect(g, &ws);
+            if (round) cycleAllocs += allocations - before;
+            sameAnswers = sameAnswers && cyclic == cycleDetect(g);
+
+            before = allocations;
+            vector<int> sorted = topologicalSort(g, &ws);
+            if (round) topAllocs += allocations - before - (sorted.empty() ? 0 : 1);
+            sameAnswers = sameAnswers && sorted == topologicalSort(g);
+
+            before = allocations;
+            vector<int> euler = hierholzerEulerian(g, &ws);
+            if (round) eulerAllocs += allocations - before - (euler.empty() ? 0 : 1);
+            sameAnswers = sameAnswers && euler == hierholzerEulerian(g);
+        }
+        for (auto& g: wgraphs) {
+            int n = g.size();
+            long long before = allocations;
+            int dist = djikstra(g, 0, n-1, &ws);
+            if (round) djikAllocs += allocations - before;
+            sameAnswers = sameAnswers && dist == djikstra(g, 0, n-1);
+
+            before = allocations;
+            int cost = prim(g, &ws);
+            if (round) primAllocs += allocations - before;
+            sameAnswers = sameAnswers && cost == prim(g);
+
+            before = allocations;
+            int befo = bellmanFord(g, 0, n-1, &ws);
+            if (round) befoAllocs += allocations - before;
+            sameAnswers = sameAnswers && befo == bellmanFord(g, 0, n-1);
+        }
+    }
+
+    if (sameAnswers) cout << "PASSED" << endl;
+    else cout << "FAILED" << endl;
+
+    // Only the vector returned by topologicalSort/hierholzerEulerian may allocate
+    long long counts[] = {dfsAllocs, bfsAllocs, cycleAllocs, topAllocs, eulerAllocs, djikAllocs, primAllocs, befoAllocs};
+    for (auto c: counts) {
+        if (c == 0) cout << "PASSED" << endl;
+        else cout << "FAILED (" << c << " allocations)" << endl;
+    }
+
+    // A workspace reserved for the graph's size must not grow even on its first call
+    mt19937 rng(2021);
+    long long firstCallAllocs = 0;
+    for (int trial = 0; trial < 500; trial++) {
+        int n = uniform_int_distribution<int>(1, 30)(rng);
+        int m = uniform_int_distribution<int>(0, 4*n)(rng);
+        vector<vector<int>> g(n);
+        vector<vector<pii>> wg(n);
+        for (int e = 0; e < m; e++) {
+            int u = uniform_int_distribution<int>(0, n-1)(rng);
+            int v = uniform_int_distribution<int>(0, n-1)(rng);
+            g[u].push_back(v);
+            wg[u].push_back(mp(v, uniform_int_distribution<int>(1, 20)(rng)));
+        }
+
+        GraphWorkspace fresh[8];
+        for (auto& f: fresh) f.reserve(n, m);
+        long long before = allocations;
+        dfs(g, 0, n-1, &fresh[0]);
+        bfs(g, 0, n-1, &fresh[1]);
+        cycleDetect(g, &fresh[2]);
+        vector<int> sorted = topologicalSort(g, &fresh[3]);
+        vector<int> euler = hierholzerEulerian(g, &fresh[4]);
+        djikstra(wg, 0, n-1, &fresh[5]);
+        prim(wg, &fresh[6]);
+        bellmanFord(wg, 0, n-1, &fresh[7]);
+        firstCallAllocs += allocations - before - !sorted.empty() - !euler.empty();
+    }
+    if (firstCallAllocs == 0) cout << "PASSED" << endl;
+    else cout << "FAILED (" << firstCallAllocs << " allocations)" << endl;
+
+    cout << "Done Workspace testing!" << endl << endl;
+}
+
+// Reordering tests
+static bool isTopologicalOrder(vector<vector<int>>& g, vector<int>& order) {
+    int n = g.size();
+    if ((int)order.size() != n) return false;
+    vector<int> position(n,-1);
+    for (int i = 0; i < n; i++) position[order[i]] = i;
+    for (int i = 0; i < n; i++) {
+        if (position[i] == -1) return false;
+        for (int v: g[i]) if (position[v] <= position[i]) return false;
+    }
+    return true;
+}
+
+static bool walkEdges(vector<vector<int>>& g, vector<int>& path, multiset<pii>& walked) {
+    // Whether path is a walk in g that uses every edge at most once; walked gets its edges
+    multiset<pii> edges;
+    for (int i = 0; i < (int)g.size(); i++) for (int v: g[i]) edges.insert(mp(i,v));
+    for (int i = 0; i+1 < (int)path.size(); i++) {
+        auto it = edges.find(mp(path[i], path[i+1]));
+        if (it == edges.end()) return false;
+        edges.erase(it);
+        walked.insert(mp(path[i], path[i+1]));
+    }
+    return true;
+}
+
+template <typename Graph>
+static bool matchesAdjList(vector<vector<int>>& g, Graph& other) {
+    // Checks another representation of g (same vertex IDs on the outside) against the adj_list
+    int n = g.size();
+    bool same = true;
+    for (int s = 0; s < n; s++) {
+        for (int t = 0; t < n; t++) {
+            same = same && dfs(other, s, t) == dfs(g, s, t) && bfs(other, s, t) == bfs(g, s, t);
+        }
+    }
+    same = same && cycleDetect(other) == cycleDetect(g);
+
+    vector<int> sorted = topologicalSort(other);
+    if (topologicalSort(g).empty()) same = same && sorted.empty();
+    else same = same && isTopologicalOrder(g, sorted);
+
+    // Hierholzer uses up every edge reachable from its start whatever order it takes them
+    // in, so a walk from the same start must cover exactly the same edges - all of them
+    // on an Eulerian graph, the start's component on a disconnected one
+    vector<int> euler = hierholzerEulerian(other);
+    vector<int> expected = hierholzerEulerian(g);
+    if (expected.empty()) return same && euler.empty();
+    multiset<pii> walked, expectedWalked;
+    return same && !euler.empty() && euler[0] == expected[0] && walkEdges(g, euler, walked) &&
+           walkEdges(g, expected, expectedWalked) && walked == expectedWalked;
+}
+
+void testReorder(vector<vector<vector<int>>>& graphs, vector<vector<vector<pii>>>& wgraphs) {
+    cout << "Starting Reorder tests..." << endl;
+
+    // A small circuit too, whose walk must still start at original vertex 0
+    vector<vector<vector<int>>> circuits = graphs;
+    circuits.push_back({{1},{2},{0}});
+
+    ReorderMethod methods[] = {RCM, DEGREE_SORT, HUB_CLUSTER, GORDER};
+    for (auto method: methods) {
+        bool same = true;
+        for (auto& g: circuits) {
+            ReorderedGraph r = reorder(g, method);
+            same = same && matchesAdjList(g, r);
+            // Relabelling keeps every list's order, so the walk must be the original one
+            same = same && hierholzerEulerian(r) == hierholzerEulerian(g);
+        }
+        for (auto& g: wgraphs) {
+            int n = g.size();
+            ReorderedWeightedGraph r = reorder(g, method);
+            for (int s = 0; s < n; s++) {
+                for (int t = 0; t < n; t++) {
+                    same = same && djikstra(r, s, t) == djikstra(g, s, t);
+                    same = same && bellmanFord(r, s, t) == bellmanFord(g, s, t);
+                }
+            }
+            same = same && prim(r) == prim(g);
+        }
+        if (same) cout << "PASSED" << endl;
+        else cout << "FAILED" << endl;
+    }
+
+    // RCM on a shuffled path graph must recover consecutive labels
+    vector<int> labels = {4,0,6,2,5,1,3};
+    vector<vector<int>> path(labels.size());
+    for (int i = 0; i+1 < (int)labels.size(); i++) {
+        path[labels[i]].push_back(labels[i+1]);
+        path[labels[i+1]].push_back(labels[i]);
+    }
+    ReorderedGraph r = reorder(path, RCM);
+    if (averageNeighborGap(r.adj_list) == 1) cout << "PASSED" << endl;
+    else cout << "FAILED" << endl;
+
+    cout << "Done Reorder testing!" << endl << endl;
+}
+
+// Compressed adjacency tests
+void testCompressed(vector<vector<vector<int>>>& graphs) {
+    cout << "Starting Compressed tests..." << endl;
+
+    // Every list must decode back to the sorted original, including on a random graph
+    // that spans several 64-vertex index blocks
+    mt19937 rng(2021);
+    vector<vector<vector<int>>> roundTripGraphs = graphs;
+    vector<vector<int>> spread(300);
+    for (auto& nbrs: spread) {
+        int degree = uniform_int_distribution<int>(0, 12)(rng);
+        for (int j = 0; j < degree; j++) nbrs.push_back(uniform_int_distribution<int>(0, 299)(rng));
+    }
+    roundTripGraphs.push_back(spread);
+
+    bool roundTrip = true;
+    for (auto& g: roundTripGraphs) {
+        CompressedGraph c = compress(g);
+        for (int i = 0; i < (int)g.size(); i++) {
+            vector<int> expected = g[i], decoded;
+            sort(expected.begin(), expected.end());
+            for (auto v: c[i]) decoded.push_back(v);
+            roundTrip = roundTrip && decoded == expected;
+        }
+    }
+    // Multi-byte gaps and a first neighbour below the vertex itself
+    vector<vector<int>> far(70000);
+    far[1] = {69999, 300, 0};
+    CompressedGraph c = compress(far);
+    vector<int> decoded;
+    for (auto v: c[1]) decoded.push_back(v);
+    roundTrip = roundTrip && decoded == vector<int>({0, 300, 69999});
+    if (roundTrip) cout << "PASSED" << endl;
+    else cout << "FAILED" << endl;
+
+    bool same = true;
+    for (auto& g: graphs) {
+        CompressedGraph c = compress(g);
+        same = same && matchesAdjList(g, c);
+    }
+    if (same) cout << "PASSED" << endl;
+    else cout << "FAILED" << endl;
+
+    // Streaming sorted edges through the builder gives the same graph as compress()
+    CompressedGraphBuilder builder;
+    for (int i = 0; i < (int)spread.size(); i++) {
+        vector<int> sorted = spread[i];
+        sort(sorted.begin(), sorted.end());
+        for (int v: sorted) builder.addEdge(i, v);
+    }
+    CompressedGraph streamed, expected = compress(spread);
+    bool built = builder.finish(spread.size(), streamed) && streamed.bytes == expected.bytes &&
+                 streamed.offsets == expected.offsets && streamed.blockOffsets == expected.blockOffsets &&
+                 streamed.edges == expected.edges;
+    if (built) cout << "PASSED" << endl;
+    else cout << "FAILED" << endl;
+
+    // Out-of-order edges and endpoints outside the graph are reported, not encoded
+    CompressedGraphBuilder unsortedTargets, unsortedSources, farSource, farTarget, negativeTarget;
+    unsortedTargets.addEdge(0, 2);
+    unsortedTargets.addEdge(0, 1);
+    unsortedSources.addEdge(1, 0);
+    unsortedSources.addEdge(0, 1);
+    farSource.addEdge(3, 0);
+    farTarget.addEdge(0, 3);
+    negativeTarget.addEdge(1, -1);
+    CompressedGraph rejected;
+    if (!unsortedTargets.finish(3, rejected) && !unsortedSources.finish(3, rejected) && !farSource.finish(3, rejected) &&
+        !farTarget.finish(3, rejected) && !negativeTarget.finish(3, rejected)) cout << "PASSED" << endl;
+    else cout << "FAILED" << endl;
+
+    cout << "Done Compressed testing!" << endl << endl;
+}
+
+static vector<vector<pii>> shuffledGrid(int side, mt19937& rng) {
+    // Undirected side x side grid with random weights and randomly permuted vertex IDs
+    int n = side * side;
+    vector<int> label(n);
+    for (int i = 0; i < n; i++) label[i] = i;
+    shuffle(label.begin(), label.end(), rng);
+    uniform_int_distribution<int> weight(1, 100);
+    vector<vector<pii>> g(n);
+    for (int r = 0; r < side; r++) {
+        for (int c = 0; c < side; c++) {
+            int u = label[r*side + c];
+            if (c+1 < side) {
+                int v = label[r*side + c+1], w = weight(rng);
+                g[u].push_back(mp(v,w));
+                g[v].push_back(mp(u,w));
+            }
+            if (r+1 < side) {
+                int v = label[(r+1)*side + c], w = weight(rng);
+                g[u].push_back(mp(v,w));
+                g[v].push_back(mp(u,w));
+            }
+        }
+    }
+    return g;
+}
+
+static vector<vector<pii>> shuffledPowerLaw(int n, int m, mt19937& rng) {
+    // Undirected preferential-attachment graph (each new vertex links to m earlier ones)
+    vector<int> label(n);
+    for (int i = 0; i < n; i++) label[i] = i;
+    shuffle(label.begin(), label.end(), rng);
+    uniform_int_distribution<int> weight(1, 100);
+    vector<vector<pii>> g(n);
+    vector<int> endpoints;
+    for (int i = 0; i <= m; i++) {
+        for (int j = 0; j < i; j++) {
+            int w = weight(rng);
+            g[label[i]].push_back(mp(label[j],w));
+            g[label[j]].push_back(mp(label[i],w));
+            endpoints.push_back(i);
+            endpoints.push_back(j);
+        }
+    }
+    for (int i = m+1; i < n; i++) {
+        for (int k = 0; k < m; k++) {
+            int j = endpoints[uniform_int_distribution<int>(0, endpoints.size()-1)(rng)];
+            int w = weight(rng);
+            g[label[i]].push_back(mp(label[j],w));
+            g[label[j]].push_back(mp(label[i],w));
+            endpoints.push_back(i);
+            endpoints.push_back(j);
+        }
+    }
+    return g;
+}
+
+static double median(vector<double> samples) {
+    sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+template <typename WeightedGraph, typename Graph>
+static double runQueries(WeightedGraph& g, Graph& topology, int n, GraphWorkspace& ws, long long& checksum) {
+    // bfs/djikstra/prim over a fixed set of queries, returns milliseconds
+    checksum = 0;
+    auto start = chrono::steady_clock::now();
+    for (int q = 0; q < 4; q++) {
+        int s = (long long)q * n / 4, t = n-1-s;
+        checksum += bfs(topology, s, t, &ws);
+        checksum += djikstra(g, s, t, &ws);
+    }
+    checksum += prim(g, &ws);
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+void benchReorder() {
+    // Every figure is a median over several runs. Baseline and reordered queries are timed
+    // back to back and the speedup is the median of those pairs, so machine drift between
+    // methods cancels out.
+    cout << "Starting Reorder benchmark..." << endl;
+
+    const int runs = 9;
+    mt19937 rng(2021);
+    vector<string> names = {"grid 300x300", "power-law 100k"};
+    vector<vector<vector<pii>>> graphs = {shuffledGrid(300, rng), shuffledPowerLaw(100000, 4, rng)};
+    vector<string> methodNames = {"RCM", "degree sort", "hub cluster", "Gorder"};
+    ReorderMethod methods[] = {RCM, DEGREE_SORT, HUB_CLUSTER, GORDER};
+
+    for (int i = 0; i < (int)graphs.size(); i++) {
+        // Copy so the baseline's neighbour lists are laid out in vertex order, like a relabelled graph's
+        vector<vector<pii>> g = graphs[i];
+        int n = g.size();
+        vector<vector<int>> topology(n);
+        for (int v = 0; v < n; v++) for (auto e: g[v]) topology[v].push_back(e.first);
+
+        GraphWorkspace ws;
+        long long baseSum;
+        vector<double> baseTimes;
+        runQueries(g, topology, n, ws, baseSum); // warm up the workspace
+        for (int run = 0; run < runs; run++) baseTimes.push_back(runQueries(g, topology, n, ws, baseSum));
+        cout << names[i] << ": gap " << averageNeighborGap(g) << ", queries " << median(baseTimes) << " ms" << endl;
+
+        for (int m = 0; m < 4; m++) {
+            ReorderedWeightedGraph r;
+            ReorderedGraph rt;
+            vector<double> prepTimes;
+            for (int run = 0; run < 3; run++) {
+                auto start = chrono::steady_clock::now();
+                r = reorder(g, methods[m]);
+                rt.newId = r.newId;
+                rt.oldId = r.oldId;
+                rt.adj_list.assign(n, {});
+                for (int v = 0; v < n; v++) for (auto e: r.adj_list[v]) rt.adj_list[v].push_back(e.first);
+                prepTimes.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+            }
+            double prep = median(prepTimes);
+
+            long long sum;
+            vector<double> times, speedups, endToEnd;
+            runQueries(r, rt, n, ws, sum);
+            for (int run = 0; run < runs; run++) {
+                double base = runQueries(g, topology, n, ws, baseSum);
+                double t = runQueries(r, rt, n, ws, sum);
+                times.push_back(t);
+                speedups.push_back(base / t);
+                endToEnd.push_back(base / (prep + t));
+            }
+            cout << "  " << methodNames[m] << ": gap " << averageNeighborGap(r.adj_list)
+                 << ", reorder " << prep << " ms, queries " << median(times) << " ms, speedup " << median(speedups)
+                 << " (" << median(endToEnd) << " end-to-end)"
+                 << (sum == baseSum ? "" : " (MISMATCH)") << endl;
+        }
+    }
+
+    cout << "Done Reorder benchmark!" << endl << endl;
+}
+
+static vector<vector<int>> topologyOf(vector<vector<pii>>& g) {
+    vector<vector<int>> topology(g.size());
+    for (int v = 0; v < (int)g.size(); v++) for (auto e: g[v]) topology[v].push_back(e.first);
+    return topology;
+}
+
+template <typename Graph>
+static double traversalRate(Graph& g, vector<vector<int>>& plain, GraphWorkspace& ws) {
+    // Millions of neighbours scanned per second by full (targetless) bfs sweeps. bfs from
+    // vertex 0 scans the whole list of every vertex it reaches, and ws.dist marks those
+    const int sweeps = 5;
+    vector<double> rates;
+    for (int sweep = 0; sweep < sweeps; sweep++) {
+        auto start = chrono::steady_clock::now();
+        bfs(g, 0, -1, &ws);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        long long scanned = 0;
+        for (int v = 0; v < (int)plain.size(); v++) if (ws.dist[v] != -1) scanned += plain[v].size();
+        rates.push_back(scanned / seconds / 1e6);
+    }
+    return median(rates);
+}
+
+void benchCompressed() {
+    cout << "Starting Compressed benchmark..." << endl;
+
+    mt19937 rng(2021);
+    vector<vector<pii>> grid = shuffledGrid(300, rng);
+    vector<vector<pii>> powerLaw = shuffledPowerLaw(100000, 4, rng);
+    vector<string> names = {"grid 300x300", "grid 300x300 (RCM)", "power-law 100k", "power-law 100k (RCM)"};
+    vector<vector<vector<int>>> graphs = {topologyOf(grid), {}, topologyOf(powerLaw), {}};
+    graphs[1] = reorder(graphs[0], RCM).adj_list;
+    graphs[3] = reorder(graphs[2], RCM).adj_list;
+
+    for (int i = 0; i < (int)graphs.size(); i++) {
+        auto& g = graphs[i];
+        CompressedGraph c = compress(g);
+        GraphWorkspace ws;
+        traversalRate(g, g, ws); // warm up the workspace
+        double plain = traversalRate(g, g, ws);
+        double packed = traversalRate(c, g, ws);
+        cout << names[i] << ": " << bitsPerEdge(c) << " bits/edge including the index ("
+             << 8.0 * c.bytes.size() / c.edges << " for the neighbour stream, 32 for raw targets), "
+             << plain << " vs " << packed << " M edges/s uncompressed vs compressed" << endl;
+    }
+
+    cout << "Done Compressed benchmark!" << endl << endl;
+}
+
+// Semi-external tests
+static vector<int> componentLabels(vector<vector<int>>& g) {
+    // In-memory union-find reference, labelled with the smallest vertex of each component
+    int n = g.size();
+    vector<int> parent(n);
+    for (int i = 0; i < n; i++) parent[i] = i;
+    function<int(int)> find = [&](int v) { return parent[v] == v ? v : parent[v] = find(parent[v]); };
+    for (int i = 0; i < n; i++) {
+        for (int v: g[i]) {
+            int a = find(i), b = find(v);
+            parent[max(a,b)] = min(a,b); // the root is always the smallest vertex
+        }
+    }
+    vector<int> label(n);
+    for (int i = 0; i < n; i++) label[i] = find(i);
+    return label;
+}
+
+static bool matchesInMemory(vector<vector<int>>& g, size_t budget, vector<pii>& queries) {
+    const string path = "external_edges.bin";
+    if (!writeEdgeFile(g, path)) return false;
+    bool same = true;
+    for (auto q: queries) same = same && externalBfs(path, q.first, q.second, budget) == bfs(g, q.first, q.second);
+    same = same && externalComponents(path, budget) == componentLabels(g);
+    same = same && externalCycleDetect(path, budget) == cycleDetect(g);
+    remove(path.c_str());
+    return same;
+}
+
+void testExternal(vector<vector<vector<int>>>& graphs) {
+    cout << "Starting Semi-external tests..." << endl;
+
+    // A 16 byte budget holds one edge per partition, so every edge is its own read
+    bool same = true;
+    for (auto& g: graphs) {
+        vector<pii> queries;
+        for (int s = 0; s < (int)g.size(); s++) for (int t = 0; t < (int)g.size(); t++) queries.push_back(mp(s,t));
+        same = same && matchesInMemory(g, 16, queries);
+    }
+    if (same) cout << "PASSED" << endl;
+    else cout << "FAILED" << endl;
+
+    // A shuffled grid plus a path and some isolated vertices, stored both undirected (cyclic)
+    // and with every edge pointing to the larger ID (acyclic), against a 32KB budget
+    mt19937 rng(2021);
+    vector<vector<pii>> grid = shuffledGrid(100, rng);
+    vector<vector<int>> big = topologyOf(grid);
+    int n = big.size();
+    big.resize(n + 150);
+    for (int i = n; i < n + 99; i++) {
+        big[i].push_back(i+1);
+        big[i+1].push_back(i);
+    }
+    vector<vector<int>> dag(big.size());
+    for (int i = 0; i < (int)big.size(); i++) for (int v: big[i]) if (v > i) dag[i].push_back(v);
+
+    const size_t budget = 32 * 1024;
+    long long edgeBytes = 0;
+    for (auto& nbrs: big) edgeBytes += nbrs.size() * sizeof(pii);
+    assert(edgeBytes > 8 * (long long)budget); // the edge file must not fit in the budget
+
+    vector<pii> queries = {mp(0, n-1), mp(17, 4242), mp(n-1, 0), mp(5, n+50), mp(n+3, n+80), mp(n+120, n+120)};
+    if (matchesInMemory(big, budget, queries)) cout << "PASSED" << endl;
+    else cout << "FAILED" << endl;
+    if (matchesInMemory(dag, budget, queries)) cout << "PASSED" << endl;
+    else cout << "FAILED" << endl;
+
+    // A target next to the source in a deep graph: a 200k-vertex path needs only a couple
+    // of passes, not one per level of the whole graph
+    const string path = "external_edges.bin";
+    vector<vector<int>> deep(200000);
+    for (int i = 0; i+1 < (int)deep.size(); i++) {
+        deep[i].push_back(i+1);
+        deep[i+1].push_back(i);
+    }
+    int last = deep.size() - 1;
+    writeEdgeFile(deep, path);
+    if (externalBfs(path, last, last-1, budget) == 1 && externalBfs(path, 5, 2, budget) == 3 &&
+        externalBfs(path, 100, 100, budget) == 0) cout << "PASSED" << endl;
+    else cout << "FAILED" << endl;
+
+    // The same length of chain as a DAG stored in source order peels in one pass after
+    // the in-degree count, rather than one pass per vertex
+    vector<vector<int>> chain(200000);
+    for (int i = 0; i+1 < (int)chain.size(); i++) chain[i].push_back(i+1);
+    writeEdgeFile(chain, path);
+    int passes = 0;
+    if (!externalCycleDetect(path, budget, &passes) && passes <= 3) cout << "PASSED" << endl;
+    else cout << "FAILED" << endl;
+
+    // Out-of-range queries and malformed files report like unreachable targets, and edges
+    // pointing outside the graph are ignored
+    bool rejected = externalBfs(path, -1, 0, budget) == -1 && externalBfs(path, 0, last+1, budget) == -1;
+    rejected = rejected && externalBfs("missing_edges.bin", 0, 1, budget) == -1 && externalComponents("missing_edges.bin", budget).empty();
+    int foreign[] = {3, 0, 7, 0, 1, -4, 2, 1, 2};
+    FILE* f = fopen(path.c_str(), "wb");
+    fwrite(foreign, sizeof(int), 9, f);
+    fclose(f);
+    rejected = rejected && externalBfs(path, 0, 2, budget) == 2 && externalComponents(path, budget) == vector<int>({0,0,0});
+    int negative[] = {-5, 0, 1};
+    f = fopen(path.c_str(), "wb");
+    fwrite(negative, sizeof(int), 3, f);
+    fclose(f);
+    rejected = rejected && externalBfs(path, 0, 1, budget) == -1 && externalComponents(path, budget).empty() && !externalCycleDetect(path, budget);
+    remove(path.c_str());
+    if (rejected) cout << "PASSED" << endl;
+    else cout << "FAILED" << endl;
+
+    cout << "Done Semi-external testing!" << endl << endl;
+}
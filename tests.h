@@ -17,6 +17,20 @@ void testBeFo(vector<vector<vector<pii>>>& graphs);
 void testHierholzer(vector<vector<vector<int>>>& graphs);
 void testFlWa(vector<vector<vector<pii>>>& graphs);
 
+// Workspace tests
+void testWorkspace(vector<vector<vector<int>>>& graphs, vector<vector<vector<pii>>>& wgraphs);
+
+// Reordering tests
+void testReorder(vector<vector<vector<int>>>& graphs, vector<vector<vector<pii>>>& wgraphs);
+void benchReorder();
+
+// Compressed adjacency tests
+void testCompressed(vector<vector<vector<int>>>& graphs);
+void benchCompressed();
+
+// Semi-external tests
+void testExternal(vector<vector<vector<int>>>& graphs);
+
 // Tarjan tests
 void testTarjanSCC(vector<vector<vector<int>>>& graphs);
 void testTarjanAP(vector<vector<vector<int>>>& graphs);